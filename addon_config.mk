@@ -10,6 +10,9 @@ meta:
 
 common:
 	ADDON_SOURCES = src/ofxSherpaOnnx.cpp
+	ADDON_SOURCES += src/ofxSherpaOnnxJournal.cpp
+	ADDON_SOURCES += src/ofxSherpaOnnxFrontEnd.cpp
+	ADDON_SOURCES += src/ofxSherpaOnnxTTSPool.cpp
 	ADDON_INCLUDES = src
 	ADDON_INCLUDES += libs/sherpa-onnx/include
 
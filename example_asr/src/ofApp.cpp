@@ -47,8 +47,16 @@ void ofApp::setup(){
         ofExit();
     }
 
+    // Setup the shared audio front-end. It downmixes and resamples the device audio
+    // once and hands it to each consumer on its own thread, so decoding no longer
+    // runs on the audio thread. Further consumers (meters, recorders) can be added the same way.
+    frontEnd.setup(modelSampleRate);
+    frontEnd.addConsumer("asr", [this](const std::vector<float>& samples, int sampleRate) {
+        sherpaOnnx.processASR(samples);
+    });
+
     // Setup sound stream
-    int bufferSize = 512; // Increased buffer size for resampling
+    int bufferSize = 512;
     int nInputChannels = 1; // mono input
     int nOutputChannels = 0; // no output (we are only capturing audio)
     int deviceSampleRate = 48000; // Use a standard sample rate your device supports
@@ -61,7 +69,7 @@ void ofApp::setup(){
     // settings.setInDevice(devices.at(0));
 
     // Setup the sound stream with the correct sample rate and buffer size
-    // We request a standard sample rate from the device, and will resample it down for the model.
+    // We request a standard sample rate from the device; the front-end resamples it down for the model.
     ofSoundStreamSettings settings;
     settings.setInListener(this);
     settings.sampleRate = deviceSampleRate;
@@ -93,41 +101,8 @@ void ofApp::draw(){
 
 //--------------------------------------------------------------
 void ofApp::audioIn(ofSoundBuffer &input){
-    
-    // Resample the input buffer if the sample rate does not match the model's required rate.
-    if (input.getSampleRate() != modelSampleRate) {
-        
-        double ratio = (double)modelSampleRate / (double)input.getSampleRate();
-        size_t resampledSize = static_cast<size_t>(std::floor(input.getNumFrames() * ratio));
-        
-        // Ensure the resampled buffer has the correct size and number of channels.
-        if (resampledBuffer.getNumFrames() != resampledSize) {
-            resampledBuffer.allocate(resampledSize, input.getNumChannels());
-        }
-        resampledBuffer.setSampleRate(modelSampleRate);
-
-        // Simple linear interpolation for resampling.
-        for (size_t i = 0; i < resampledBuffer.getNumFrames(); ++i) {
-            double source_index = i / ratio;
-            size_t index_0 = static_cast<size_t>(source_index);
-            size_t index_1 = std::min(index_0 + 1, input.getNumFrames() - 1);
-            double frac = source_index - index_0;
-
-            for (size_t j = 0; j < resampledBuffer.getNumChannels(); ++j) {
-                float sample0 = input.getSample(index_0, j);
-                float sample1 = input.getSample(index_1, j);
-                float resampled_sample = sample0 + (sample1 - sample0) * frac;
-                resampledBuffer.getSample(i, j) = resampled_sample;
-            }
-        }
-        
-        // Pass the resampled audio buffer to ofxSherpaOnnx for processing.
-        sherpaOnnx.processASR(resampledBuffer);
-
-    } else {
-        // If sample rates match, process the buffer directly.
-        sherpaOnnx.processASR(input);
-    }
+    // Downmix and resample once into the front-end; the ASR consumer picks it up from there.
+    frontEnd.process(input);
 }
 
 //--------------------------------------------------------------
@@ -151,6 +126,8 @@ void ofApp::exit(){
     // Stop and close the sound stream
     soundStream.stop();
     soundStream.close();
+    // Stop the consumer threads
+    frontEnd.close();
 }
 
 //--------------------------------------------------------------
@@ -13,6 +13,7 @@
 
 #include "ofMain.h"
 #include "ofxSherpaOnnx.h"
+#include "ofxSherpaOnnxFrontEnd.h"
 
 class ofApp : public ofBaseApp {
 
@@ -41,8 +42,8 @@ public:
 		void onFinalResultReceived(std::string& result);
 
 		ofxSherpaOnnx sherpaOnnx;
+		ofxSherpaOnnxFrontEnd frontEnd;
 		ofSoundStream soundStream;
-		ofSoundBuffer resampledBuffer;
 
 		unsigned int modelSampleRate;
 		std::string currentRecognition;
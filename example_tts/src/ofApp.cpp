@@ -24,12 +24,12 @@ void ofApp::setup(){
     // It will download the necessary model for this example into:
     // `ofxSherpaOnnx/example_tts/bin/data/models/vits-piper-en_US-amy-low/`
 
-    std::string modelPath = "models/vits-piper-en_US-amy-low/model.onnx";
-    std::string lexiconPath = "models/vits-piper-en_US-amy-low/lexicon.txt";
-    std::string tokensPath = "models/vits-piper-en_US-amy-low/tokens.txt";
-    float noiseScale = 0.667f;
-    float noiseW = 0.8f;
-    float lengthScale = 1.0f;
+    modelPath = "models/vits-piper-en_US-amy-low/model.onnx";
+    lexiconPath = "models/vits-piper-en_US-amy-low/lexicon.txt";
+    tokensPath = "models/vits-piper-en_US-amy-low/tokens.txt";
+    noiseScale = 0.667f;
+    noiseW = 0.8f;
+    lengthScale = 1.0f;
     
     // Ensure paths are relative to your data folder
     modelPath = ofToDataPath(modelPath, true);
@@ -68,7 +68,7 @@ void ofApp::update(){
 //--------------------------------------------------------------
 void ofApp::draw(){
     ofSetColor(255);
-    ofDrawBitmapString("Enter text and press 'Generate Speech'", 20, 30);
+    ofDrawBitmapString("Enter text and press 'Generate Speech' (F1 runs the TTS pool benchmark, see console)", 20, 30);
     
     gui.draw();
     
@@ -128,6 +128,92 @@ void ofApp::onGenerateSpeechButtonPressed(){
     }
 }
 
+//--------------------------------------------------------------
+void ofApp::runBenchmark(){
+    // Open-loop load sweep: requests arrive at a fixed rate, and each configuration
+    // reports the highest throughput it sustains while p99 latency stays under the
+    // target. Serial generateTTS() and the one-engine pool both use a single engine,
+    // so the gap between them is the pool's own overhead; the two-engine pool shows
+    // what a second engine adds. Blocks while it runs.
+    const int requestsPerStep = 24;
+    const float p99TargetMs = 1000.0f;
+    const std::vector<float> loadFactors = {0.25f, 0.5f, 0.75f, 0.9f, 1.0f, 1.25f, 1.5f};
+    std::vector<std::string> texts;
+    for (int i = 0; i < requestsPerStep; ++i) {
+        texts.push_back("Request number " + ofToString(i) + ", please stand by.");
+    }
+
+    // Calibrate one engine's service time so the sweep brackets its capacity.
+    std::vector<float> samples;
+    int sampleRate;
+    auto calibrationStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < 4; ++i) {
+        sherpaOnnx.generateTTS(texts[i], samples, sampleRate);
+    }
+    float serviceSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - calibrationStart).count() / 4;
+    float engineCapacity = 1.0f / std::max(serviceSeconds, 0.001f);
+    ofLogNotice("ofApp") << "One engine: " << serviceSeconds * 1000.0f << " ms per utterance, about " << engineCapacity << " utterances/s";
+
+    // numEngines 0 is the serial generateTTS() baseline.
+    for (int numEngines : {0, 1, 2}) {
+        std::string name = numEngines == 0 ? "Serial generateTTS()" : "Pool, " + ofToString(numEngines) + (numEngines == 1 ? " engine" : " engines");
+        if (numEngines > 0) {
+            ofxSherpaOnnxTTSPool::Settings settings;
+            settings.numEngines = numEngines;
+            if (!ttsPool.setup(modelPath, lexiconPath, tokensPath, noiseScale, noiseW, lengthScale, settings)) {
+                ofLogError("ofApp") << "Failed to set up the TTS pool.";
+                return;
+            }
+        }
+
+        float bestRate = 0.0f;
+        for (float factor : loadFactors) {
+            float offeredRate = factor * engineCapacity * std::max(1, numEngines);
+            auto interval = std::chrono::duration<double>(1.0 / offeredRate);
+            auto start = std::chrono::steady_clock::now();
+            auto arrival = [&](int i) { return start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval * i); };
+
+            float achievedRate = 0.0f;
+            float p99LatencyMs = 0.0f;
+            if (numEngines == 0) {
+                // A request that arrives while the previous one is synthesizing waits for it.
+                std::vector<float> latencies;
+                for (int i = 0; i < requestsPerStep; ++i) {
+                    std::this_thread::sleep_until(arrival(i));
+                    sherpaOnnx.generateTTS(texts[i], samples, sampleRate);
+                    latencies.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - arrival(i)).count());
+                }
+                achievedRate = requestsPerStep / std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+                std::sort(latencies.begin(), latencies.end());
+                p99LatencyMs = latencies[(latencies.size() - 1) * 99 / 100];
+            } else {
+                ttsPool.resetStats();
+                std::vector<std::future<ofxSherpaOnnxTTSPool::Result>> results;
+                for (int i = 0; i < requestsPerStep; ++i) {
+                    std::this_thread::sleep_until(arrival(i));
+                    results.push_back(ttsPool.submit(texts[i]));
+                }
+                for (auto& result : results) {
+                    result.wait();
+                }
+                ofxSherpaOnnxTTSPool::Stats stats = ttsPool.getStats();
+                achievedRate = stats.utterancesPerSecond;
+                p99LatencyMs = stats.p99LatencyMs;
+            }
+
+            ofLogNotice("ofApp") << name << ": offered " << offeredRate << "/s, achieved " << achievedRate << "/s, p99 " << p99LatencyMs << " ms";
+            if (p99LatencyMs <= p99TargetMs) {
+                bestRate = std::max(bestRate, achievedRate);
+            }
+        }
+        ofLogNotice("ofApp") << name << ": " << bestRate << " utterances/s at p99 <= " << p99TargetMs << " ms";
+
+        if (numEngines > 0) {
+            ttsPool.close();
+        }
+    }
+}
+
 //--------------------------------------------------------------
 void ofApp::exit(){
     generateSpeechButton.removeListener(this, &ofApp::onGenerateSpeechButtonPressed);
@@ -136,7 +222,10 @@ void ofApp::exit(){
 
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key){
-
+    // F1 rather than a letter, so typing into the text field does not trigger it.
+    if (key == OF_KEY_F1 && !isSpeaking) {
+        runBenchmark();
+    }
 }
 
 //--------------------------------------------------------------
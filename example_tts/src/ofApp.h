@@ -13,6 +13,7 @@
 
 #include "ofMain.h"
 #include "ofxSherpaOnnx.h"
+#include "ofxSherpaOnnxTTSPool.h"
 #include "ofxGui.h" // For a simple GUI to input text
 
 class ofApp : public ofBaseApp {
@@ -36,8 +37,12 @@ public:
     void gotMessage(ofMessage msg) override;
 
     void onGenerateSpeechButtonPressed();
+    void runBenchmark();
 
     ofxSherpaOnnx sherpaOnnx;
+    ofxSherpaOnnxTTSPool ttsPool; // Only set up when the benchmark runs
+    std::string modelPath, lexiconPath, tokensPath;
+    float noiseScale, noiseW, lengthScale;
     ofSoundPlayer soundPlayer; // To play the generated speech
 
     ofxPanel gui;
@@ -12,90 +12,496 @@
 #include "ofxSherpaOnnx.h"
 #include <cstring> // For memset
 
+namespace {
+    const float tailHistorySeconds = 1.0f;  // Must exceed one decode chunk plus its context
+    const float defaultChunkSeconds = 0.4f; // Used until the decode step size has been learned
+    const float tailContextSeconds = 0.1f;  // Right context and feature window on top of a chunk
+}
+
 ofxSherpaOnnx::ofxSherpaOnnx() {}
 
 ofxSherpaOnnx::~ofxSherpaOnnx() {
-    if (stream) {
-        SherpaOnnxDestroyOnlineStream(stream);
-    }
-    if (recognizer) {
-        SherpaOnnxDestroyOnlineRecognizer(recognizer);
-    }
+    disableSecondPass();
+    stopSwapLoader();
+    stopStreamRecycler();
+    destroyASRModel(asrModel);
     if (ttsSynthesizer) {
         SherpaOnnxDestroyOfflineTts(ttsSynthesizer);
     }
 }
 
 // ASR (Speech-to-Text)
-bool ofxSherpaOnnx::setupASR(const std::string& encoderPath, const std::string& decoderPath, const std::string& joinerPath, const std::string& tokensPath, int sampleRate, const std::string& modelType) {
+void ofxSherpaOnnx::setDecodingMethod(const std::string& method, int newMaxActivePaths) {
+    decodingMethod = method;
+    maxActivePaths = newMaxActivePaths;
+}
+
+bool ofxSherpaOnnx::validateASRModelPaths(const ASRModelPaths& paths, const std::string& module) {
+    if (paths.modelType != "transducer") {
+        ofLogError(module) << "Unsupported model type for this setup method: " << paths.modelType;
+        return false;
+    }
+    if (!ofFile::doesFileExist(paths.tokens)) {
+        ofLogError(module) << "Tokens file not found: " << paths.tokens;
+        return false;
+    }
+    if (!ofFile::doesFileExist(paths.encoder) || !ofFile::doesFileExist(paths.decoder) || !ofFile::doesFileExist(paths.joiner)) {
+        ofLogError(module) << "One or more ASR model files not found.";
+        return false;
+    }
+    return true;
+}
+
+const SherpaOnnxOnlineRecognizer* ofxSherpaOnnx::createRecognizer(const ASRModelPaths& paths, const std::string& method) {
     SherpaOnnxOnlineRecognizerConfig config{};
     
-    config.feat_config.sample_rate = sampleRate;
+    config.feat_config.sample_rate = asrSampleRate;
     config.feat_config.feature_dim = 80;
 
     config.model_config.num_threads = 1;
     config.model_config.debug = 0;
     config.model_config.provider = "cpu";
-    config.model_config.tokens = tokensPath.c_str();
-    config.model_config.model_type = modelType.c_str();
+    config.model_config.tokens = paths.tokens.c_str();
+    config.model_config.model_type = paths.modelType.c_str();
 
-    if (modelType == "transducer") {
-        config.model_config.transducer.encoder = encoderPath.c_str();
-        config.model_config.transducer.decoder = decoderPath.c_str();
-        config.model_config.transducer.joiner = joinerPath.c_str();
-    } else {
-        ofLogError("ofxSherpaOnnx::setupASR") << "Unsupported model type for this setup method: " << modelType;
-        return false;
-    }
+    config.model_config.transducer.encoder = paths.encoder.c_str();
+    config.model_config.transducer.decoder = paths.decoder.c_str();
+    config.model_config.transducer.joiner = paths.joiner.c_str();
 
-    config.decoding_method = "greedy_search";
-    config.max_active_paths = 4;
+    config.decoding_method = method.c_str();
+    config.max_active_paths = maxActivePaths;
     config.enable_endpoint = 1;
     config.rule1_min_trailing_silence = 2.4;
     config.rule2_min_trailing_silence = 1.2;
     config.rule3_min_utterance_length = 300;
 
-    if (!ofFile::doesFileExist(tokensPath)) {
-        ofLogError("ofxSherpaOnnx::setupASR") << "Tokens file not found: " << tokensPath;
+    return SherpaOnnxCreateOnlineRecognizer(&config);
+}
+
+bool ofxSherpaOnnx::loadASRModel(const ASRModelPaths& paths, bool withFallback, ASRModel& model) {
+    model.recognizer = createRecognizer(paths, decodingMethod);
+    if (!model.recognizer) {
+        ofLogError("ofxSherpaOnnx::loadASRModel") << "Failed to create recognizer.";
         return false;
     }
-    if (!ofFile::doesFileExist(encoderPath) || !ofFile::doesFileExist(decoderPath) || !ofFile::doesFileExist(joinerPath)) {
-        ofLogError("ofxSherpaOnnx::setupASR") << "One or more ASR model files not found.";
+
+    model.stream = SherpaOnnxCreateOnlineStream(model.recognizer);
+    if (!model.stream) {
+        ofLogError("ofxSherpaOnnx::loadASRModel") << "Failed to create stream.";
+        destroyASRModel(model);
         return false;
     }
 
-    recognizer = SherpaOnnxCreateOnlineRecognizer(&config);
-    if (!recognizer) {
-        ofLogError("ofxSherpaOnnx::setupASR") << "Failed to create recognizer.";
+    if (withFallback && decodingMethod != "greedy_search") {
+        model.fallbackRecognizer = createRecognizer(paths, "greedy_search");
+        if (model.fallbackRecognizer) {
+            model.fallbackStream = SherpaOnnxCreateOnlineStream(model.fallbackRecognizer);
+        }
+        if (!model.fallbackStream) {
+            ofLogWarning("ofxSherpaOnnx::loadASRModel") << "Failed to create greedy fallback decoder; overload fallback disabled.";
+            if (model.fallbackRecognizer) {
+                SherpaOnnxDestroyOnlineRecognizer(model.fallbackRecognizer);
+                model.fallbackRecognizer = nullptr;
+            }
+        }
+    }
+    return true;
+}
+
+void ofxSherpaOnnx::warmUpRecognizer(const SherpaOnnxOnlineRecognizer* warmRecognizer) {
+    // Run half a second of silence through a throwaway stream so the first real
+    // decode after a swap does not pay for lazy allocations inside onnxruntime.
+    const SherpaOnnxOnlineStream* warmStream = SherpaOnnxCreateOnlineStream(warmRecognizer);
+    if (!warmStream) return;
+    std::vector<float> silence(asrSampleRate / 2, 0.0f);
+    SherpaOnnxOnlineStreamAcceptWaveform(warmStream, asrSampleRate, silence.data(), silence.size());
+    while (SherpaOnnxIsOnlineStreamReady(warmRecognizer, warmStream)) {
+        SherpaOnnxDecodeOnlineStream(warmRecognizer, warmStream);
+    }
+    const SherpaOnnxOnlineRecognizerResult* result = SherpaOnnxGetOnlineStreamResult(warmRecognizer, warmStream);
+    if (result) {
+        SherpaOnnxDestroyOnlineRecognizerResult(result);
+    }
+    SherpaOnnxDestroyOnlineStream(warmStream);
+}
+
+void ofxSherpaOnnx::destroyASRModel(ASRModel& model) {
+    if (model.fallbackStream) {
+        SherpaOnnxDestroyOnlineStream(model.fallbackStream);
+    }
+    if (model.fallbackRecognizer) {
+        SherpaOnnxDestroyOnlineRecognizer(model.fallbackRecognizer);
+    }
+    if (model.stream) {
+        SherpaOnnxDestroyOnlineStream(model.stream);
+    }
+    if (model.recognizer) {
+        SherpaOnnxDestroyOnlineRecognizer(model.recognizer);
+    }
+    model = ASRModel();
+}
+
+bool ofxSherpaOnnx::setupASR(const std::string& encoderPath, const std::string& decoderPath, const std::string& joinerPath, const std::string& tokensPath, int sampleRate, const std::string& modelType) {
+    ASRModelPaths paths{ encoderPath, decoderPath, joinerPath, tokensPath, modelType };
+    if (!validateASRModelPaths(paths, "ofxSherpaOnnx::setupASR")) {
         return false;
     }
 
-    stream = SherpaOnnxCreateOnlineStream(recognizer);
-    if (!stream) {
-        ofLogError("ofxSherpaOnnx::setupASR") << "Failed to create stream.";
+    // Release any model from a previous setupASR() or swap before replacing it.
+    stopSwapLoader();
+    stopStreamRecycler();
+    destroyASRModel(asrModel);
+    activeRecognizer = nullptr;
+    activeStream = nullptr;
+
+    asrSampleRate = sampleRate;
+    {
+        std::lock_guard<std::mutex> lock(loadMutex);
+        loadPolicy = pendingLoadPolicy;
+        loadPolicyChanged = false;
+        loadStatus = ofxSherpaOnnxLoadStatus();
+        publishedLoadStatus = loadStatus;
+    }
+
+    if (!loadASRModel(paths, loadPolicy.fallbackToGreedy, asrModel)) {
         return false;
     }
+    activeRecognizer = asrModel.recognizer;
+    activeStream = asrModel.stream;
+
+    samplesAccepted = 0;
+    segmentStartSample = 0;
+    tailHistory.assign(static_cast<size_t>(tailHistorySeconds * asrSampleRate), 0.0f);
+    tailHistoryWritten = 0;
+    segmentAudio.clear();
+    segmentAudioOverflow = false;
+    undecodedSamples = 0;
+    samplesPerIteration = 0.0;
+    wallLagSeconds = 0.0;
+    startStreamRecycler();
 
     ofLogNotice("ofxSherpaOnnx::setupASR") << "SherpaOnnx ASR setup complete.";
     return true;
 }
 
+bool ofxSherpaOnnx::swapASRModel(const std::string& encoderPath, const std::string& decoderPath, const std::string& joinerPath, const std::string& tokensPath, const std::string& modelType) {
+    if (!asrModel.recognizer) {
+        ofLogError("ofxSherpaOnnx::swapASRModel") << "ASR not initialized. Call setupASR() first.";
+        return false;
+    }
+    ASRModelPaths paths{ encoderPath, decoderPath, joinerPath, tokensPath, modelType };
+    if (!validateASRModelPaths(paths, "ofxSherpaOnnx::swapASRModel")) {
+        return false;
+    }
+    if (swapInProgress.exchange(true)) {
+        ofLogWarning("ofxSherpaOnnx::swapASRModel") << "A model swap is already in progress.";
+        return false;
+    }
+
+    if (swapThread.joinable()) {
+        swapThread.join();
+    }
+    swapAbort = false;
+    swapThread = std::thread(&ofxSherpaOnnx::swapLoaderThread, this, paths);
+    return true;
+}
+
+void ofxSherpaOnnx::swapLoaderThread(ASRModelPaths paths) {
+    bool withFallback;
+    {
+        std::lock_guard<std::mutex> lock(loadMutex);
+        withFallback = pendingLoadPolicy.fallbackToGreedy;
+    }
+
+    ASRModel model;
+    if (!loadASRModel(paths, withFallback, model)) {
+        ofLogError("ofxSherpaOnnx::swapASRModel") << "Failed to load new model; keeping the current one.";
+        swapInProgress = false;
+        return;
+    }
+    warmUpRecognizer(model.recognizer);
+    if (model.fallbackRecognizer) {
+        warmUpRecognizer(model.fallbackRecognizer);
+    }
+
+    std::unique_lock<std::mutex> lock(swapMutex);
+    pendingModel = model;
+    swapReady = true;
+    ofLogNotice("ofxSherpaOnnx::swapASRModel") << "New model loaded; swapping at the next endpoint.";
+
+    swapCondition.wait(lock, [this] { return swapDone.load() || swapAbort.load(); });
+    if (swapDone) {
+        destroyASRModel(retiredModel);
+        swapDone = false;
+        ofLogNotice("ofxSherpaOnnx::swapASRModel") << "Model swap complete; previous model released.";
+    }
+    swapInProgress = false;
+}
+
+void ofxSherpaOnnx::stopSwapLoader() {
+    {
+        std::lock_guard<std::mutex> lock(swapMutex);
+        swapAbort = true;
+    }
+    swapCondition.notify_all();
+    if (swapThread.joinable()) {
+        swapThread.join();
+    }
+    // A model that was loaded but never reached an endpoint is still ours to free.
+    destroyASRModel(pendingModel);
+    destroyASRModel(retiredModel);
+    swapReady = false;
+    swapDone = false;
+    swapInProgress = false;
+}
+
+void ofxSherpaOnnx::applyPendingModel() {
+    // Wait until a recycled stream is back in its slot, so the retired model is complete.
+    if (!swapReady.load() || recycleInFlight) return;
+    std::unique_lock<std::mutex> lock(swapMutex, std::try_to_lock);
+    if (!lock.owns_lock()) return;
+
+    retiredModel = asrModel;
+    asrModel = pendingModel;
+    pendingModel = ASRModel();
+    swapReady = false;
+    swapDone = true;
+    lock.unlock();
+    swapCondition.notify_one();
+
+    activeRecognizer = asrModel.recognizer;
+    activeStream = asrModel.stream;
+    replayTail(activeStream);
+    if (loadStatus.usingFallbackDecoder) {
+        loadStatus.usingFallbackDecoder = false;
+        ofNotifyEvent(onLoadStateChanged, loadStatus, this);
+    }
+}
+
 void ofxSherpaOnnx::processASR(const std::vector<float>& audioBuffer) {
-    if (!recognizer || !stream) return;
-    SherpaOnnxOnlineStreamAcceptWaveform(stream, 16000, audioBuffer.data(), audioBuffer.size());
-    while (SherpaOnnxIsOnlineStreamReady(recognizer, stream)) {
-        SherpaOnnxDecodeOnlineStream(recognizer, stream);
+    if (!activeRecognizer || !activeStream) return;
+
+    if (recycleReady.load()) {
+        collectRecycledStream();
+    }
+    if (loadPolicyChanged.load()) {
+        std::unique_lock<std::mutex> lock(loadMutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            loadPolicy = pendingLoadPolicy;
+            loadPolicyChanged = false;
+        }
+    }
+
+    auto decodeStart = std::chrono::steady_clock::now();
+    if (loadStatus.shedding) {
+        loadStatus.droppedSeconds += static_cast<double>(audioBuffer.size()) / asrSampleRate;
+    } else {
+        SherpaOnnxOnlineStreamAcceptWaveform(activeStream, asrSampleRate, audioBuffer.data(), audioBuffer.size());
+        samplesAccepted += audioBuffer.size();
+        undecodedSamples += audioBuffer.size();
+        recordTail(audioBuffer);
+        if (secondPassActive.load()) {
+            if (samplesAccepted - audioBuffer.size() == segmentStartSample) {
+                acquireSegmentBuffer();
+            }
+            // Never grow the buffer here; a segment that does not fit, or that began
+            // before a buffer was available, keeps its first-pass text.
+            bool complete = segmentAudio.size() == samplesAccepted - audioBuffer.size() - segmentStartSample;
+            if (!segmentAudioOverflow && complete && segmentAudio.size() + audioBuffer.size() <= segmentAudio.capacity()) {
+                segmentAudio.insert(segmentAudio.end(), audioBuffer.begin(), audioBuffer.end());
+            } else {
+                segmentAudioOverflow = true;
+            }
+        }
     }
-    updateRecognitionResults();
-    if (SherpaOnnxOnlineStreamIsEndpoint(recognizer, stream)) {
+    int iterations = 0;
+    bool drained = true;
+    while (SherpaOnnxIsOnlineStreamReady(activeRecognizer, activeStream)) {
+        if (loadPolicy.maxDecodeIterations > 0 && iterations >= loadPolicy.maxDecodeIterations) {
+            drained = false;
+            break;
+        }
+        SherpaOnnxDecodeOnlineStream(activeRecognizer, activeStream);
+        iterations++;
+    }
+    double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - decodeStart).count();
+    updateLoadState(audioBuffer.size(), decodeSeconds, iterations, drained);
+
+    bool isEndpoint = SherpaOnnxOnlineStreamIsEndpoint(activeRecognizer, activeStream);
+    bool skipPartials = loadStatus.overloaded && loadPolicy.skipPartialsWhenOverloaded;
+    if (!skipPartials || isEndpoint) {
+        updateRecognitionResults(!skipPartials);
+    }
+    if (isEndpoint) {
         if (!currentText.empty()) {
-            finalText = currentText;
-            ofNotifyEvent(onFinalResult, finalText, this);
+            double startSeconds = static_cast<double>(segmentStartSample) / asrSampleRate;
+            double endSeconds = static_cast<double>(samplesAccepted) / asrSampleRate;
+            if (secondPassActive.load() || !pendingFinals.empty()) {
+                queueFinalResult(currentText, startSeconds, endSeconds);
+            } else {
+                emitFinalResult(currentText, startSeconds, endSeconds);
+            }
             currentText = "";
             lastResultText = "";
         }
-        SherpaOnnxOnlineStreamReset(recognizer, stream);
+        segmentAudio.clear();
+        segmentAudioOverflow = false;
+        SherpaOnnxOnlineStreamReset(activeRecognizer, activeStream);
+        segmentStartSample = samplesAccepted;
+
+        // Switch models or decoders only at an endpoint with the old stream drained.
+        // It can still hold up to one chunk it has not decoded, which replayTail()
+        // carries over into the new stream.
+        if (drained) {
+            applyPendingModel();
+        }
+        bool wantFallback = asrModel.fallbackRecognizer && loadStatus.overloaded && loadPolicy.fallbackToGreedy;
+        if (wantFallback != loadStatus.usingFallbackDecoder && drained && !recycleInFlight) {
+            const SherpaOnnxOnlineRecognizer* nextRecognizer = wantFallback ? asrModel.fallbackRecognizer : asrModel.recognizer;
+            const SherpaOnnxOnlineStream* nextStream = wantFallback ? asrModel.fallbackStream : asrModel.stream;
+            std::unique_lock<std::mutex> lock(recycleMutex, std::try_to_lock);
+            // nextStream is null only if recycling it failed; stay on the current decoder then.
+            if (nextStream && lock.owns_lock()) {
+                recycleRecognizer = activeRecognizer;
+                recycleStaleStream = activeStream;
+                if (activeStream == asrModel.stream) {
+                    asrModel.stream = nullptr;
+                } else {
+                    asrModel.fallbackStream = nullptr;
+                }
+                recycleInFlight = true;
+                lock.unlock();
+                recycleCondition.notify_one();
+
+                activeRecognizer = nextRecognizer;
+                activeStream = nextStream;
+                replayTail(activeStream);
+                loadStatus.usingFallbackDecoder = wantFallback;
+                ofNotifyEvent(onLoadStateChanged, loadStatus, this);
+            }
+        }
+    }
+
+    if (!pendingFinals.empty()) {
+        flushPendingFinals();
+    }
+
+    std::unique_lock<std::mutex> lock(loadMutex, std::try_to_lock);
+    if (lock.owns_lock()) {
+        publishedLoadStatus = loadStatus;
+    }
+}
+
+void ofxSherpaOnnx::startStreamRecycler() {
+    recycleThread = std::thread(&ofxSherpaOnnx::streamRecycleLoop, this);
+}
+
+void ofxSherpaOnnx::stopStreamRecycler() {
+    {
+        std::lock_guard<std::mutex> lock(recycleMutex);
+        recycleStop = true;
+    }
+    recycleCondition.notify_all();
+    if (recycleThread.joinable()) {
+        recycleThread.join();
+    }
+    // The recognizer is about to be destroyed with the model, so the empty slot stays empty.
+    if (recycleStaleStream) {
+        SherpaOnnxDestroyOnlineStream(recycleStaleStream);
+    }
+    if (recycleFreshStream) {
+        SherpaOnnxDestroyOnlineStream(recycleFreshStream);
+    }
+    recycleRecognizer = nullptr;
+    recycleStaleStream = nullptr;
+    recycleFreshStream = nullptr;
+    recycleStop = false;
+    recycleReady = false;
+    recycleInFlight = false;
+}
+
+void ofxSherpaOnnx::streamRecycleLoop() {
+    std::unique_lock<std::mutex> lock(recycleMutex);
+    while (true) {
+        recycleCondition.wait(lock, [this] { return recycleStop || recycleStaleStream; });
+        if (recycleStop) return;
+        const SherpaOnnxOnlineRecognizer* recognizer = recycleRecognizer;
+        const SherpaOnnxOnlineStream* stale = recycleStaleStream;
+        lock.unlock();
+
+        SherpaOnnxDestroyOnlineStream(stale);
+        const SherpaOnnxOnlineStream* fresh = SherpaOnnxCreateOnlineStream(recognizer);
+        if (!fresh) {
+            ofLogError("ofxSherpaOnnx::streamRecycleLoop") << "Failed to create a replacement stream; that decoder stays unused.";
+        }
+
+        lock.lock();
+        recycleStaleStream = nullptr;
+        recycleFreshStream = fresh;
+        recycleReady = true;
+    }
+}
+
+void ofxSherpaOnnx::collectRecycledStream() {
+    std::unique_lock<std::mutex> lock(recycleMutex, std::try_to_lock);
+    if (!lock.owns_lock()) return;
+    if (recycleRecognizer == asrModel.recognizer) {
+        asrModel.stream = recycleFreshStream;
+    } else if (recycleRecognizer == asrModel.fallbackRecognizer) {
+        asrModel.fallbackStream = recycleFreshStream;
+    }
+    recycleRecognizer = nullptr;
+    recycleFreshStream = nullptr;
+    recycleReady = false;
+    recycleInFlight = false;
+}
+
+void ofxSherpaOnnx::recordTail(const std::vector<float>& audioBuffer) {
+    size_t size = tailHistory.size();
+    if (size == 0) return;
+    // Only the last `size` samples of a large buffer can survive in the ring.
+    size_t skip = audioBuffer.size() > size ? audioBuffer.size() - size : 0;
+    for (size_t i = skip; i < audioBuffer.size(); ++i) {
+        tailHistory[(tailHistoryWritten + i) % size] = audioBuffer[i];
+    }
+    tailHistoryWritten += audioBuffer.size();
+}
+
+void ofxSherpaOnnx::replayTail(const SherpaOnnxOnlineStream* stream) {
+    // A drained stream holds less than one decode chunk it has not consumed yet.
+    // Replay one learned chunk plus context. At an endpoint the audio before the
+    // tail is trailing silence, so replaying a little too much costs nothing.
+    size_t chunk = samplesPerIteration > 0.0 ? static_cast<size_t>(samplesPerIteration)
+                                             : static_cast<size_t>(defaultChunkSeconds * asrSampleRate);
+    uint64_t count = std::min<uint64_t>({ chunk + static_cast<uint64_t>(tailContextSeconds * asrSampleRate),
+                                          tailHistory.size(), tailHistoryWritten });
+    if (!stream || count == 0) return;
+
+    size_t size = tailHistory.size();
+    size_t offset = (tailHistoryWritten - count) % size;
+    size_t first = std::min<size_t>(count, size - offset);
+    SherpaOnnxOnlineStreamAcceptWaveform(stream, asrSampleRate, tailHistory.data() + offset, first);
+    if (count > first) {
+        SherpaOnnxOnlineStreamAcceptWaveform(stream, asrSampleRate, tailHistory.data(), count - first);
     }
+    undecodedSamples += count;
+}
+
+void ofxSherpaOnnx::emitFinalResult(const std::string& text, double startSeconds, double endSeconds) {
+    {
+        std::lock_guard<std::mutex> lock(finalTextMutex);
+        finalText = text;
+    }
+    if (ofxSherpaOnnxJournal* j = journal.load()) {
+        ofxSherpaOnnxTranscriptEntry entry;
+        entry.wallTimeMs = ofGetSystemTimeMillis();
+        entry.startSeconds = startSeconds;
+        entry.endSeconds = endSeconds;
+        entry.text = text;
+        j->append(std::move(entry));
+    }
+    std::string notifiedText = text;
+    ofNotifyEvent(onFinalResult, notifiedText, this);
 }
 
 void ofxSherpaOnnx::processASR(const ofSoundBuffer& soundBuffer) {
@@ -103,14 +509,53 @@ void ofxSherpaOnnx::processASR(const ofSoundBuffer& soundBuffer) {
     processASR(audioBuffer);
 }
 
-void ofxSherpaOnnx::updateRecognitionResults() {
-    if (!recognizer || !stream) return;
-    const SherpaOnnxOnlineRecognizerResult* result = SherpaOnnxGetOnlineStreamResult(recognizer, stream);
+void ofxSherpaOnnx::updateLoadState(size_t samplesReceived, double decodeSeconds, int iterations, bool drained) {
+    double receivedSeconds = static_cast<double>(samplesReceived) / asrSampleRate;
+
+    // Decoding for longer than the audio it covers means the caller (usually the
+    // audio thread) is falling behind the device by the difference.
+    wallLagSeconds = std::max(0.0, wallLagSeconds + decodeSeconds - receivedSeconds);
+
+    if (drained) {
+        if (iterations > 0) {
+            double observed = static_cast<double>(undecodedSamples) / iterations;
+            samplesPerIteration = samplesPerIteration > 0.0 ? 0.9 * samplesPerIteration + 0.1 * observed : observed;
+            undecodedSamples = 0;
+        }
+    } else {
+        uint64_t consumed = static_cast<uint64_t>(iterations * samplesPerIteration);
+        undecodedSamples = undecodedSamples > consumed ? undecodedSamples - consumed : 0;
+    }
+
+    if (receivedSeconds > 0.0) {
+        loadStatus.realTimeFactor = 0.9f * loadStatus.realTimeFactor + 0.1f * static_cast<float>(decodeSeconds / receivedSeconds);
+    }
+    float backlog = static_cast<float>(static_cast<double>(undecodedSamples) / asrSampleRate + wallLagSeconds);
+    loadStatus.backlogSeconds = backlog;
+
+    bool overloaded = loadStatus.overloaded ? backlog > loadPolicy.recoverBacklogSeconds
+                                            : backlog >= loadPolicy.overloadBacklogSeconds;
+    bool sheddable = streamPriority.load() < loadPolicy.shedBelowPriority;
+    bool shedding = sheddable && (loadStatus.shedding ? backlog > loadPolicy.recoverBacklogSeconds
+                                                      : backlog >= loadPolicy.shedBacklogSeconds);
+
+    if (overloaded != loadStatus.overloaded || shedding != loadStatus.shedding) {
+        loadStatus.overloaded = overloaded;
+        loadStatus.shedding = shedding;
+        ofNotifyEvent(onLoadStateChanged, loadStatus, this);
+    }
+}
+
+void ofxSherpaOnnx::updateRecognitionResults(bool notifyPartial) {
+    if (!activeRecognizer || !activeStream) return;
+    const SherpaOnnxOnlineRecognizerResult* result = SherpaOnnxGetOnlineStreamResult(activeRecognizer, activeStream);
     if (result && result->text && strlen(result->text) > 0) {
         std::string newText = result->text;
         if (newText != lastResultText) {
             currentText = newText;
-            ofNotifyEvent(onPartialResult, currentText, this);
+            if (notifyPartial) {
+                ofNotifyEvent(onPartialResult, currentText, this);
+            }
             lastResultText = newText;
         }
     }
@@ -119,8 +564,282 @@ void ofxSherpaOnnx::updateRecognitionResults() {
     }
 }
 
+void ofxSherpaOnnx::setJournal(ofxSherpaOnnxJournal* newJournal) {
+    journal = newJournal;
+}
+
+void ofxSherpaOnnx::setLoadPolicy(const ofxSherpaOnnxLoadPolicy& policy) {
+    std::lock_guard<std::mutex> lock(loadMutex);
+    pendingLoadPolicy = policy;
+    loadPolicyChanged = true;
+}
+
+void ofxSherpaOnnx::setStreamPriority(int priority) {
+    streamPriority = priority;
+}
+
+ofxSherpaOnnxLoadStatus ofxSherpaOnnx::getLoadStatus() {
+    std::lock_guard<std::mutex> lock(loadMutex);
+    return publishedLoadStatus;
+}
+
+float ofxSherpaOnnx::getBacklogSeconds() {
+    return getLoadStatus().backlogSeconds;
+}
+
+// Two-pass recognition
+bool ofxSherpaOnnx::setupSecondPass(const ofxSherpaOnnxSecondPassSettings& settings) {
+    disableSecondPass();
+
+    SherpaOnnxOfflineRecognizerConfig config{};
+
+    config.feat_config.sample_rate = asrSampleRate;
+    config.feat_config.feature_dim = 80;
+
+    config.model_config.num_threads = settings.numThreads;
+    config.model_config.debug = 0;
+    config.model_config.provider = "cpu";
+    config.model_config.tokens = settings.tokensPath.c_str();
+
+    if (settings.modelType == "whisper") {
+        if (!ofFile::doesFileExist(settings.encoderPath) || !ofFile::doesFileExist(settings.decoderPath)) {
+            ofLogError("ofxSherpaOnnx::setupSecondPass") << "Whisper encoder or decoder not found.";
+            return false;
+        }
+        config.model_config.whisper.encoder = settings.encoderPath.c_str();
+        config.model_config.whisper.decoder = settings.decoderPath.c_str();
+        config.model_config.whisper.language = settings.language.c_str();
+        config.model_config.whisper.task = "transcribe";
+        config.model_config.whisper.tail_paddings = -1;
+    } else if (settings.modelType == "paraformer") {
+        if (!ofFile::doesFileExist(settings.modelPath)) {
+            ofLogError("ofxSherpaOnnx::setupSecondPass") << "Paraformer model not found: " << settings.modelPath;
+            return false;
+        }
+        config.model_config.paraformer.model = settings.modelPath.c_str();
+    } else {
+        ofLogError("ofxSherpaOnnx::setupSecondPass") << "Unsupported second-pass model type: " << settings.modelType;
+        return false;
+    }
+    if (!ofFile::doesFileExist(settings.tokensPath)) {
+        ofLogError("ofxSherpaOnnx::setupSecondPass") << "Tokens file not found: " << settings.tokensPath;
+        return false;
+    }
+
+    config.decoding_method = "greedy_search";
+
+    secondPassRecognizer = SherpaOnnxCreateOfflineRecognizer(&config);
+    if (!secondPassRecognizer) {
+        ofLogError("ofxSherpaOnnx::setupSecondPass") << "Failed to create offline recognizer.";
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(secondPassMutex);
+        secondPassQueue.clear();
+        secondPassRescoresQueued = 0;
+        secondPassStats = ofxSherpaOnnxSecondPassStats();
+        secondPassMaxQueueDepth = std::max<size_t>(1, settings.maxQueueDepth);
+        secondPassAccepting = true;
+
+        // One buffer per queued rescore, plus the segment being recorded and the
+        // one being decoded, so processASR never allocates for segment audio.
+        secondPassSegmentSamples = static_cast<size_t>(std::max(1.0f, settings.maxSegmentSeconds) * asrSampleRate);
+        spareBuffers.clear();
+        spareBuffers.resize(secondPassMaxQueueDepth + 2);
+        for (auto& buffer : spareBuffers) {
+            buffer.reserve(secondPassSegmentSamples);
+        }
+        secondPassGeneration++;
+    }
+    secondPassThread = std::thread(&ofxSherpaOnnx::secondPassLoop, this);
+    secondPassActive = true;
+
+    ofLogNotice("ofxSherpaOnnx::setupSecondPass") << "Second pass enabled with " << settings.modelType << " model.";
+    return true;
+}
+
+void ofxSherpaOnnx::disableSecondPass() {
+    {
+        std::lock_guard<std::mutex> lock(secondPassMutex);
+        secondPassAccepting = false;
+    }
+    secondPassCondition.notify_all();
+    // The worker emits everything still queued before it exits.
+    if (secondPassThread.joinable()) {
+        secondPassThread.join();
+    }
+    secondPassActive = false;
+    {
+        std::lock_guard<std::mutex> lock(secondPassMutex);
+        spareBuffers.clear();
+    }
+    if (secondPassRecognizer) {
+        SherpaOnnxDestroyOfflineRecognizer(secondPassRecognizer);
+        secondPassRecognizer = nullptr;
+    }
+}
+
+void ofxSherpaOnnx::queueFinalResult(const std::string& firstPassText, double startSeconds, double endSeconds) {
+    SecondPassSegment segment;
+    segment.firstPassText = firstPassText;
+    segment.startSeconds = startSeconds;
+    segment.endSeconds = endSeconds;
+    segment.enqueuedAt = std::chrono::steady_clock::now();
+    if (segmentAudioOverflow || segmentAudio.empty()) {
+        // Too long for the offline model, or no buffer was free when it started.
+        segment.rescore = false;
+    } else {
+        segment.audio.swap(segmentAudio);
+        if (!localSpareBuffers.empty()) {
+            segmentAudio.swap(localSpareBuffers.back());
+            localSpareBuffers.pop_back();
+        }
+    }
+    pendingFinals.push_back(std::move(segment));
+}
+
+void ofxSherpaOnnx::acquireSegmentBuffer() {
+    bool stale = localSpareGeneration != secondPassGeneration.load();
+    if (stale || (segmentAudio.capacity() == 0 && localSpareBuffers.empty())) {
+        std::unique_lock<std::mutex> lock(secondPassMutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            collectSpareBuffers();
+        }
+    }
+    // Zero capacity, or sized for an earlier setupSecondPass(): take a current spare.
+    if (segmentAudio.capacity() != localSegmentSamples) {
+        std::vector<float>().swap(segmentAudio);
+        if (!localSpareBuffers.empty()) {
+            segmentAudio.swap(localSpareBuffers.back());
+            localSpareBuffers.pop_back();
+        }
+    }
+}
+
+void ofxSherpaOnnx::collectSpareBuffers() {
+    if (localSpareGeneration != secondPassGeneration.load()) {
+        // setupSecondPass() ran again; buffers from before may have another size.
+        localSpareBuffers.clear();
+        localSpareGeneration = secondPassGeneration.load();
+        localSegmentSamples = secondPassSegmentSamples;
+    }
+    while (!spareBuffers.empty() && localSpareBuffers.size() < secondPassMaxQueueDepth + 2) {
+        localSpareBuffers.push_back(std::move(spareBuffers.back()));
+        spareBuffers.pop_back();
+    }
+}
+
+void ofxSherpaOnnx::flushPendingFinals() {
+    if (!secondPassActive.load()) {
+        // The worker has drained and exited; nothing of ours can still be ahead of these.
+        for (auto& segment : pendingFinals) {
+            emitFinalResult(segment.firstPassText, segment.startSeconds, segment.endSeconds);
+        }
+        pendingFinals.clear();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(secondPassMutex, std::try_to_lock);
+    // Busy or shutting down: keep them in order and retry on the next call.
+    if (!lock.owns_lock() || !secondPassAccepting) return;
+    collectSpareBuffers();
+
+    for (auto& segment : pendingFinals) {
+        if (segment.rescore && secondPassRescoresQueued >= secondPassMaxQueueDepth) {
+            // The worker is behind: keep the first-pass text, but still queue it so
+            // final results are emitted in order.
+            segment.rescore = false;
+        }
+        if (segment.rescore) {
+            secondPassRescoresQueued++;
+        } else {
+            secondPassStats.segmentsSkipped++;
+            if (segment.audio.capacity() == localSegmentSamples) {
+                segment.audio.clear();
+                localSpareBuffers.push_back(std::move(segment.audio));
+            }
+        }
+        secondPassQueue.push_back(std::move(segment));
+    }
+    pendingFinals.clear();
+    secondPassStats.queueDepth = secondPassQueue.size();
+    secondPassStats.maxQueueDepthSeen = std::max(secondPassStats.maxQueueDepthSeen, secondPassQueue.size());
+    lock.unlock();
+    secondPassCondition.notify_one();
+}
+
+void ofxSherpaOnnx::secondPassLoop() {
+    while (true) {
+        SecondPassSegment segment;
+        bool stopping = false;
+        {
+            std::unique_lock<std::mutex> lock(secondPassMutex);
+            secondPassCondition.wait(lock, [this] { return !secondPassAccepting || !secondPassQueue.empty(); });
+            if (secondPassQueue.empty()) return; // Only reached once disabled and drained
+            segment = std::move(secondPassQueue.front());
+            secondPassQueue.pop_front();
+            if (segment.rescore) {
+                secondPassRescoresQueued--;
+            }
+            stopping = !secondPassAccepting;
+            if (stopping && segment.rescore) {
+                // Shutting down: flush the rest with their first-pass text rather than decode it.
+                segment.rescore = false;
+                secondPassStats.segmentsSkipped++;
+            }
+            secondPassStats.queueDepth = secondPassQueue.size();
+        }
+
+        std::string text;
+        if (segment.rescore) {
+            const SherpaOnnxOfflineStream* offlineStream = SherpaOnnxCreateOfflineStream(secondPassRecognizer);
+            if (offlineStream) {
+                SherpaOnnxAcceptWaveformOffline(offlineStream, asrSampleRate, segment.audio.data(), segment.audio.size());
+                SherpaOnnxDecodeOfflineStream(secondPassRecognizer, offlineStream);
+                const SherpaOnnxOfflineRecognizerResult* result = SherpaOnnxGetOfflineStreamResult(offlineStream);
+                if (result && result->text) {
+                    text = ofTrim(result->text);
+                }
+                if (result) {
+                    SherpaOnnxDestroyOfflineRecognizerResult(result);
+                }
+                SherpaOnnxDestroyOfflineStream(offlineStream);
+            }
+        }
+        if (text.empty()) {
+            text = segment.firstPassText;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(secondPassMutex);
+            if (segment.rescore) {
+                float latencyMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - segment.enqueuedAt).count();
+                secondPassStats.segmentsRescored++;
+                secondPassStats.lastLatencyMs = latencyMs;
+                secondPassStats.averageLatencyMs = secondPassStats.segmentsRescored == 1 ? latencyMs
+                    : 0.9f * secondPassStats.averageLatencyMs + 0.1f * latencyMs;
+            }
+            if (segment.audio.capacity() == secondPassSegmentSamples && !stopping) {
+                segment.audio.clear();
+                spareBuffers.push_back(std::move(segment.audio));
+            }
+        }
+
+        emitFinalResult(text, segment.startSeconds, segment.endSeconds);
+    }
+}
+
+ofxSherpaOnnxSecondPassStats ofxSherpaOnnx::getSecondPassStats() {
+    std::lock_guard<std::mutex> lock(secondPassMutex);
+    return secondPassStats;
+}
+
 std::string ofxSherpaOnnx::getCurrentText() { return currentText; }
-std::string ofxSherpaOnnx::getFinalText() { return finalText; }
+std::string ofxSherpaOnnx::getFinalText() {
+    std::lock_guard<std::mutex> lock(finalTextMutex);
+    return finalText;
+}
 
 // TTS (Text-to-Speech)
 bool ofxSherpaOnnx::setupTTS(const std::string& modelPath, const std::string& lexiconPath, const std::string& tokensPath, float noiseScale, float noiseW, float lengthScale) {
@@ -179,15 +898,16 @@ bool ofxSherpaOnnx::setupTTS(const std::string& modelPath, const std::string& le
 }
 
 bool ofxSherpaOnnx::generateTTS(const std::string& text, std::vector<float>& audioSamples, int& sampleRate) {
+    return generateTTS(text, audioSamples, sampleRate, 0, 1.0f);
+}
+
+bool ofxSherpaOnnx::generateTTS(const std::string& text, std::vector<float>& audioSamples, int& sampleRate, int speakerId, float speed) {
     if (!ttsSynthesizer) {
         ofLogError("ofxSherpaOnnx::generateTTS") << "TTS not initialized. Call setupTTS() first.";
         return false;
     }
 
-    float speed = 1.0f;
-    int sid = 0; // Speaker ID
-
-    const SherpaOnnxGeneratedAudio* audio = SherpaOnnxOfflineTtsGenerate(ttsSynthesizer, text.c_str(), sid, speed);
+    const SherpaOnnxGeneratedAudio* audio = SherpaOnnxOfflineTtsGenerate(ttsSynthesizer, text.c_str(), speakerId, speed);
 
     if (!audio || !audio->samples) {
         ofLogError("ofxSherpaOnnx::generateTTS") << "Failed to generate audio for text: " << text;
@@ -13,6 +13,49 @@
 
 #include "ofMain.h"
 #include "sherpa-onnx/c-api/c-api.h"
+#include "ofxSherpaOnnxJournal.h"
+
+// Degradation applied when ASR decoding falls behind real time.
+struct ofxSherpaOnnxLoadPolicy {
+    float overloadBacklogSeconds = 1.0f;   // Backlog at which the stream counts as overloaded
+    float recoverBacklogSeconds = 0.25f;   // Backlog below which normal operation resumes
+    bool skipPartialsWhenOverloaded = true; // Stop fetching/firing partial results while overloaded
+    bool fallbackToGreedy = true;          // Switch beam search to greedy search at the next endpoint
+    int maxDecodeIterations = 0;           // Cap on decode steps per processASR() call, 0 = unlimited
+    float shedBacklogSeconds = 3.0f;       // Backlog at which low-priority streams drop incoming audio
+    int shedBelowPriority = 0;             // Streams with a priority below this value may be shed
+};
+
+struct ofxSherpaOnnxLoadStatus {
+    bool overloaded = false;
+    bool shedding = false;
+    bool usingFallbackDecoder = false;
+    float backlogSeconds = 0.0f;    // Seconds of audio received but not yet decoded
+    float realTimeFactor = 0.0f;    // Smoothed decode time / audio duration
+    double droppedSeconds = 0.0;    // Audio discarded by load shedding since setupASR()
+};
+
+// Offline model used to re-decode each endpointed segment in two-pass mode.
+struct ofxSherpaOnnxSecondPassSettings {
+    std::string modelType;   // "whisper" or "paraformer"
+    std::string encoderPath; // Whisper encoder
+    std::string decoderPath; // Whisper decoder
+    std::string modelPath;   // Paraformer model
+    std::string tokensPath;
+    std::string language;    // Whisper language code, empty for auto-detect
+    int numThreads = 1;
+    size_t maxQueueDepth = 8; // Segments beyond this keep their first-pass text
+    float maxSegmentSeconds = 30.0f; // Longer segments keep their first-pass text (Whisper decodes at most 30 s)
+};
+
+struct ofxSherpaOnnxSecondPassStats {
+    size_t queueDepth = 0;
+    size_t maxQueueDepthSeen = 0;
+    uint64_t segmentsRescored = 0;
+    uint64_t segmentsSkipped = 0; // Kept their first-pass text (queue full, segment too long, or shutting down)
+    float lastLatencyMs = 0.0f;   // Endpoint to corrected final result
+    float averageLatencyMs = 0.0f;
+};
 
 class ofxSherpaOnnx {
 public:
@@ -20,7 +63,16 @@ public:
     ~ofxSherpaOnnx();
 
     // ASR (Speech-to-Text)
+    // "greedy_search" (default) or "modified_beam_search"; call before setupASR().
+    void setDecodingMethod(const std::string& method, int maxActivePaths = 4);
+    // Calling setupASR() again releases the previous model; it must not run concurrently with processASR().
     bool setupASR(const std::string& encoderPath, const std::string& decoderPath, const std::string& joinerPath, const std::string& tokensPath, int sampleRate, const std::string& modelType);
+    // Loads and warms a new model on a background thread while the current one keeps
+    // decoding, then swaps it in at the next endpoint. The old model is released on the
+    // loader thread once processASR() no longer references it. Returns false if ASR is
+    // not set up, a swap is already in progress, or the model files are missing.
+    bool swapASRModel(const std::string& encoderPath, const std::string& decoderPath, const std::string& joinerPath, const std::string& tokensPath, const std::string& modelType);
+    bool isModelSwapPending() const { return swapInProgress.load(); }
     void processASR(const std::vector<float>& audioBuffer);
     void processASR(const ofSoundBuffer& soundBuffer);
     std::string getCurrentText();
@@ -28,18 +80,157 @@ public:
     ofEvent<std::string> onPartialResult;
     ofEvent<std::string> onFinalResult;
 
+    // Every final result is appended to the journal (if set) without blocking the caller.
+    // The journal must outlive this object or be unset with setJournal(nullptr).
+    void setJournal(ofxSherpaOnnxJournal* journal);
+
+    // Overload protection. onLoadStateChanged fires (on the processASR thread)
+    // whenever the stream enters or leaves the overloaded or shedding state.
+    // The greedy fallback decoder is only built if the policy is set before setupASR().
+    void setLoadPolicy(const ofxSherpaOnnxLoadPolicy& policy);
+    void setStreamPriority(int priority);
+    ofxSherpaOnnxLoadStatus getLoadStatus();
+    float getBacklogSeconds();
+    ofEvent<ofxSherpaOnnxLoadStatus> onLoadStateChanged;
+
+    // Two-pass recognition. Partials keep coming from the online model; each
+    // endpointed segment is re-decoded by the offline model on a worker thread,
+    // which then fires onFinalResult (from that thread) with the corrected text.
+    // While it is enabled every final goes through that thread, so results stay
+    // in order. disableSecondPass() emits whatever is still queued before returning.
+    // Call after setupASR().
+    bool setupSecondPass(const ofxSherpaOnnxSecondPassSettings& settings);
+    void disableSecondPass();
+    ofxSherpaOnnxSecondPassStats getSecondPassStats();
+
     // TTS (Text-to-Speech)
     bool setupTTS(const std::string& modelPath, const std::string& lexiconPath, const std::string& tokensPath, float noiseScale, float noiseW, float lengthScale);
     bool generateTTS(const std::string& text, std::vector<float>& audioSamples, int& sampleRate);
+    bool generateTTS(const std::string& text, std::vector<float>& audioSamples, int& sampleRate, int speakerId, float speed);
 
 private:
     // ASR members
-    const SherpaOnnxOnlineRecognizer* recognizer = nullptr;
-    const SherpaOnnxOnlineStream* stream = nullptr;
+    struct ASRModelPaths {
+        std::string encoder, decoder, joiner, tokens, modelType;
+    };
+    // A recognizer with its live stream, plus the optional greedy fallback pair.
+    // The fallback pair is created up front so switching to it at an endpoint
+    // never allocates on the audio thread.
+    struct ASRModel {
+        const SherpaOnnxOnlineRecognizer* recognizer = nullptr;
+        const SherpaOnnxOnlineStream* stream = nullptr;
+        const SherpaOnnxOnlineRecognizer* fallbackRecognizer = nullptr;
+        const SherpaOnnxOnlineStream* fallbackStream = nullptr;
+    };
+    ASRModel asrModel;
+    bool validateASRModelPaths(const ASRModelPaths& paths, const std::string& module);
+    const SherpaOnnxOnlineRecognizer* createRecognizer(const ASRModelPaths& paths, const std::string& method);
+    bool loadASRModel(const ASRModelPaths& paths, bool withFallback, ASRModel& model);
+    void warmUpRecognizer(const SherpaOnnxOnlineRecognizer* warmRecognizer);
+    static void destroyASRModel(ASRModel& model);
+    std::string decodingMethod = "greedy_search";
+    int maxActivePaths = 4;
     std::string currentText;
     std::string finalText;
-    void updateRecognitionResults();
+    std::mutex finalTextMutex; // finalText is written by the second-pass worker in two-pass mode
+    void updateRecognitionResults(bool notifyPartial);
     std::string lastResultText; // To track changes and fire events
+    int asrSampleRate = 16000;
+    uint64_t samplesAccepted = 0;    // Total samples fed to the stream
+    uint64_t segmentStartSample = 0; // samplesAccepted at the last endpoint
+    // Ring of the most recently accepted samples, preallocated by setupASR(). A stream
+    // that is replaced can still hold audio it accepted but has not decoded yet, so
+    // that tail is replayed into the stream taking over.
+    std::vector<float> tailHistory;
+    uint64_t tailHistoryWritten = 0;
+    void recordTail(const std::vector<float>& audioBuffer);
+    void replayTail(const SherpaOnnxOnlineStream* stream);
+    std::atomic<ofxSherpaOnnxJournal*> journal{nullptr};
+    void emitFinalResult(const std::string& text, double startSeconds, double endSeconds);
+
+    // Two-pass members. processASR collects finals in pendingFinals and hands them
+    // to the worker under a try_lock, so the audio path never waits on it. Segment
+    // audio lives in buffers preallocated to maxSegmentSeconds that circulate
+    // between the two threads through the spare lists.
+    struct SecondPassSegment {
+        std::vector<float> audio;
+        std::string firstPassText;
+        double startSeconds = 0.0;
+        double endSeconds = 0.0;
+        std::chrono::steady_clock::time_point enqueuedAt;
+        bool rescore = true; // false: emit firstPassText as-is
+    };
+    void queueFinalResult(const std::string& firstPassText, double startSeconds, double endSeconds);
+    void flushPendingFinals();
+    void acquireSegmentBuffer();
+    void collectSpareBuffers(); // Requires secondPassMutex
+    void secondPassLoop();
+    const SherpaOnnxOfflineRecognizer* secondPassRecognizer = nullptr;
+    std::atomic<bool> secondPassActive{false}; // From setupSecondPass() until the worker has drained and exited
+    // Owned by the processASR thread
+    std::vector<float> segmentAudio;
+    bool segmentAudioOverflow = false; // The current segment did not fit its buffer
+    std::deque<SecondPassSegment> pendingFinals;
+    std::vector<std::vector<float>> localSpareBuffers;
+    uint64_t localSpareGeneration = 0; // secondPassGeneration the local spares belong to
+    size_t localSegmentSamples = 0;
+    // Guarded by secondPassMutex
+    std::thread secondPassThread;
+    std::mutex secondPassMutex; // Only try_lock'ed from processASR
+    std::condition_variable secondPassCondition;
+    std::deque<SecondPassSegment> secondPassQueue;
+    std::vector<std::vector<float>> spareBuffers; // Returned by the worker for reuse
+    size_t secondPassMaxQueueDepth = 8;
+    size_t secondPassSegmentSamples = 0; // Capacity of every segment buffer
+    std::atomic<uint64_t> secondPassGeneration{0}; // Bumped by each setupSecondPass()
+    size_t secondPassRescoresQueued = 0;
+    bool secondPassAccepting = false;
+    ofxSherpaOnnxSecondPassStats secondPassStats;
+
+    // Hot swap members. The loader thread publishes pendingModel, processASR
+    // exchanges it with asrModel at an endpoint and hands the old one back.
+    void swapLoaderThread(ASRModelPaths paths);
+    void stopSwapLoader();
+    std::thread swapThread;
+    std::mutex swapMutex; // Guards pendingModel/retiredModel; only try_lock'ed from processASR
+    std::condition_variable swapCondition;
+    ASRModel pendingModel;
+    ASRModel retiredModel;
+    std::atomic<bool> swapReady{false};   // pendingModel is loaded and waiting for an endpoint
+    std::atomic<bool> swapDone{false};    // retiredModel holds the model that was swapped out
+    std::atomic<bool> swapAbort{false};
+    std::atomic<bool> swapInProgress{false};
+    void applyPendingModel();
+
+    // Load protection members
+    const SherpaOnnxOnlineRecognizer* activeRecognizer = nullptr;
+    const SherpaOnnxOnlineStream* activeStream = nullptr;
+    void updateLoadState(size_t samplesReceived, double decodeSeconds, int iterations, bool drained);
+    std::mutex loadMutex; // Guards pendingLoadPolicy and publishedLoadStatus; only try_lock'ed from processASR
+    ofxSherpaOnnxLoadPolicy pendingLoadPolicy;
+    ofxSherpaOnnxLoadStatus publishedLoadStatus;
+    std::atomic<bool> loadPolicyChanged{false};
+    ofxSherpaOnnxLoadPolicy loadPolicy;  // Copy owned by the processASR thread
+    ofxSherpaOnnxLoadStatus loadStatus;  // Copy owned by the processASR thread
+    std::atomic<int> streamPriority{0};
+    // A stream switched away from keeps its undecoded tail, so the recycler thread
+    // replaces it with a fresh one before it can be switched back to.
+    void startStreamRecycler();
+    void stopStreamRecycler();
+    void streamRecycleLoop();
+    void collectRecycledStream();
+    std::thread recycleThread;
+    std::mutex recycleMutex; // Guards the recycle* fields below; only try_lock'ed from processASR
+    std::condition_variable recycleCondition;
+    const SherpaOnnxOnlineRecognizer* recycleRecognizer = nullptr;
+    const SherpaOnnxOnlineStream* recycleStaleStream = nullptr;
+    const SherpaOnnxOnlineStream* recycleFreshStream = nullptr;
+    bool recycleStop = false;
+    std::atomic<bool> recycleReady{false}; // recycleFreshStream is waiting to be installed
+    bool recycleInFlight = false;          // Owned by the processASR thread
+    uint64_t undecodedSamples = 0;     // Samples accepted but not yet consumed by the decoder
+    double samplesPerIteration = 0.0;  // Learned average samples consumed per decode step
+    double wallLagSeconds = 0.0;       // Time spent decoding beyond the duration of the audio received
 
     // TTS members
     const SherpaOnnxOfflineTts* ttsSynthesizer = nullptr;
@@ -0,0 +1,225 @@
+/*
+ * ofxSherpaOnnx
+ *
+ * Copyright (c) 2025 Yannick Hofmann
+ * <contact@yannickhofmann.de>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include "ofxSherpaOnnxFrontEnd.h"
+
+ofxSherpaOnnxFrontEnd::ofxSherpaOnnxFrontEnd() {}
+
+ofxSherpaOnnxFrontEnd::~ofxSherpaOnnxFrontEnd() {
+    close();
+}
+
+bool ofxSherpaOnnxFrontEnd::setup(int newSampleRate, float ringSeconds) {
+    close();
+
+    if (newSampleRate <= 0 || ringSeconds <= 0.0f) {
+        ofLogError("ofxSherpaOnnxFrontEnd::setup") << "Sample rate and ring length must be positive.";
+        return false;
+    }
+    sampleRate = newSampleRate;
+
+    // Power-of-two ring so positions can be masked instead of divided.
+    ringSize = 1;
+    while (ringSize < static_cast<uint64_t>(ringSeconds * sampleRate)) {
+        ringSize <<= 1;
+    }
+    ring.reset(new std::atomic<float>[ringSize]);
+    for (uint64_t i = 0; i < ringSize; ++i) {
+        ring[i].store(0.0f, std::memory_order_relaxed);
+    }
+    ringMask = ringSize - 1;
+    writePosition = 0;
+
+    resamplePosition = 0.0;
+    lastInputSample = 0.0f;
+    lastInputRate = 0;
+
+    ofLogNotice("ofxSherpaOnnxFrontEnd::setup") << "Front-end running at " << sampleRate << " Hz with a " << ringSize << " sample ring.";
+    return true;
+}
+
+void ofxSherpaOnnxFrontEnd::close() {
+    std::vector<std::unique_ptr<ConsumerSlot>> stopping;
+    {
+        std::lock_guard<std::mutex> lock(consumersMutex);
+        stopping.swap(consumers);
+    }
+    for (auto& consumer : stopping) {
+        stopConsumer(*consumer);
+    }
+}
+
+void ofxSherpaOnnxFrontEnd::process(const ofSoundBuffer& input) {
+    if (!ring) return;
+
+    size_t numFrames = input.getNumFrames();
+    size_t numChannels = input.getNumChannels();
+    if (numFrames == 0 || numChannels == 0) return;
+
+    // Downmix once for every consumer.
+    if (monoBuffer.size() < numFrames) {
+        monoBuffer.resize(numFrames);
+    }
+    const std::vector<float>& interleaved = input.getBuffer();
+    float channelGain = 1.0f / numChannels;
+    for (size_t i = 0; i < numFrames; ++i) {
+        float sum = 0.0f;
+        for (size_t c = 0; c < numChannels; ++c) {
+            sum += interleaved[i * numChannels + c];
+        }
+        monoBuffer[i] = sum * channelGain;
+    }
+
+    // Resample once, with linear interpolation that carries its phase across buffers.
+    unsigned inputRate = input.getSampleRate();
+    const float* out = monoBuffer.data();
+    size_t outCount = numFrames;
+    if (inputRate != static_cast<unsigned>(sampleRate)) {
+        if (inputRate != lastInputRate) {
+            resamplePosition = 0.0;
+            lastInputSample = monoBuffer[0];
+            lastInputRate = inputRate;
+        }
+        double step = static_cast<double>(inputRate) / sampleRate;
+        size_t maxOut = static_cast<size_t>(std::ceil(numFrames / step)) + 2;
+        if (resampledBuffer.size() < maxOut) {
+            resampledBuffer.resize(maxOut);
+        }
+        outCount = 0;
+        // resamplePosition may be in [-1, 0), which interpolates from the previous buffer's last sample.
+        while (resamplePosition < static_cast<double>(numFrames - 1)) {
+            double floorPos = std::floor(resamplePosition);
+            long i0 = static_cast<long>(floorPos);
+            float frac = static_cast<float>(resamplePosition - floorPos);
+            float s0 = i0 < 0 ? lastInputSample : monoBuffer[i0];
+            float s1 = monoBuffer[i0 + 1];
+            resampledBuffer[outCount++] = s0 + (s1 - s0) * frac;
+            resamplePosition += step;
+        }
+        resamplePosition -= numFrames;
+        lastInputSample = monoBuffer[numFrames - 1];
+        out = resampledBuffer.data();
+    }
+
+    // Publish into the ring. Consumers detect being lapped via writePosition.
+    uint64_t position = writePosition.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < outCount; ++i) {
+        ring[(position + i) & ringMask].store(out[i], std::memory_order_relaxed);
+    }
+    writePosition.store(position + outCount, std::memory_order_release);
+    wakeCondition.notify_all();
+}
+
+int ofxSherpaOnnxFrontEnd::addConsumer(const std::string& name, Consumer callback, size_t blockSize, float maxLagSeconds) {
+    if (!ring) {
+        ofLogError("ofxSherpaOnnxFrontEnd::addConsumer") << "Front-end not initialized. Call setup() first.";
+        return -1;
+    }
+    // Keep half the ring as headroom for a write in flight while a consumer copies.
+    uint64_t lagLimit = ringSize / 2;
+    if (blockSize > ringSize / 4) {
+        ofLogWarning("ofxSherpaOnnxFrontEnd::addConsumer") << "Block size for " << name << " clamped to " << ringSize / 4 << " samples.";
+        blockSize = ringSize / 4;
+    }
+
+    std::unique_ptr<ConsumerSlot> consumer(new ConsumerSlot());
+    consumer->name = name;
+    consumer->callback = callback;
+    consumer->blockSize = blockSize;
+    consumer->maxLagSamples = maxLagSeconds > 0.0f ? std::min<uint64_t>(lagLimit, static_cast<uint64_t>(maxLagSeconds * sampleRate)) : lagLimit;
+    consumer->cursor = writePosition.load();
+    consumer->readPosition = consumer->cursor;
+
+    std::lock_guard<std::mutex> lock(consumersMutex);
+    consumer->id = nextConsumerId++;
+    consumer->thread = std::thread(&ofxSherpaOnnxFrontEnd::consumerLoop, this, consumer.get());
+    consumers.push_back(std::move(consumer));
+    return consumers.back()->id;
+}
+
+void ofxSherpaOnnxFrontEnd::removeConsumer(int id) {
+    std::unique_ptr<ConsumerSlot> removed;
+    {
+        std::lock_guard<std::mutex> lock(consumersMutex);
+        auto it = std::find_if(consumers.begin(), consumers.end(), [id](const std::unique_ptr<ConsumerSlot>& c) { return c->id == id; });
+        if (it == consumers.end()) return;
+        removed = std::move(*it);
+        consumers.erase(it);
+    }
+    stopConsumer(*removed);
+}
+
+void ofxSherpaOnnxFrontEnd::stopConsumer(ConsumerSlot& consumer) {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        consumer.running = false;
+    }
+    wakeCondition.notify_all();
+    if (consumer.thread.joinable()) {
+        consumer.thread.join();
+    }
+}
+
+std::vector<ofxSherpaOnnxFrontEnd::ConsumerStats> ofxSherpaOnnxFrontEnd::getConsumerStats() {
+    std::vector<ConsumerStats> stats;
+    uint64_t written = writePosition.load();
+    std::lock_guard<std::mutex> lock(consumersMutex);
+    for (auto& consumer : consumers) {
+        ConsumerStats s;
+        s.name = consumer->name;
+        s.samplesDelivered = consumer->samplesDelivered.load();
+        s.samplesDropped = consumer->samplesDropped.load();
+        uint64_t read = consumer->readPosition.load();
+        s.lagSeconds = written > read ? static_cast<float>(written - read) / sampleRate : 0.0f;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+void ofxSherpaOnnxFrontEnd::consumerLoop(ConsumerSlot* consumer) {
+    std::vector<float> block;
+    uint64_t maxChunk = ringSize / 4;
+
+    while (consumer->running.load()) {
+        uint64_t written = writePosition.load(std::memory_order_acquire);
+        uint64_t lag = written - consumer->cursor;
+
+        if (lag > consumer->maxLagSamples) {
+            // Too far behind: jump to the newest audio rather than stall the others.
+            consumer->samplesDropped += lag;
+            consumer->cursor = written;
+            lag = 0;
+        }
+
+        uint64_t want = consumer->blockSize > 0 ? consumer->blockSize : std::min(lag, maxChunk);
+        if (want == 0 || lag < want) {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCondition.wait_for(lock, std::chrono::milliseconds(20), [&] {
+                return !consumer->running.load() || writePosition.load() - consumer->cursor >= std::max<uint64_t>(want, 1);
+            });
+            continue;
+        }
+
+        block.resize(want);
+        for (uint64_t i = 0; i < want; ++i) {
+            block[i] = ring[(consumer->cursor + i) & ringMask].load(std::memory_order_relaxed);
+        }
+        // If the writer lapped us while copying, the block is torn; drop it.
+        if (writePosition.load(std::memory_order_acquire) - consumer->cursor > ringSize / 2) {
+            continue;
+        }
+
+        consumer->cursor += want;
+        consumer->readPosition = consumer->cursor;
+        consumer->samplesDelivered += want;
+        consumer->callback(block, sampleRate);
+    }
+}
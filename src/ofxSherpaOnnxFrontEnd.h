@@ -0,0 +1,94 @@
+/*
+ * ofxSherpaOnnx
+ *
+ * Copyright (c) 2025 Yannick Hofmann
+ * <contact@yannickhofmann.de>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Shared audio front-end. process() downmixes and resamples each device buffer
+// once into a ring buffer; every registered consumer reads from it on its own
+// thread with its own cursor. The audio thread never waits on a consumer: one
+// that falls further behind than the ring (or its maxLagSeconds) skips ahead and
+// the skipped samples are counted as dropped.
+class ofxSherpaOnnxFrontEnd {
+public:
+    // Called on the consumer's thread with mono samples at the front-end sample rate.
+    typedef std::function<void(const std::vector<float>& samples, int sampleRate)> Consumer;
+
+    struct ConsumerStats {
+        std::string name;
+        uint64_t samplesDelivered = 0;
+        uint64_t samplesDropped = 0;
+        float lagSeconds = 0.0f; // Audio written but not yet read by this consumer
+    };
+
+    ofxSherpaOnnxFrontEnd();
+    ~ofxSherpaOnnxFrontEnd();
+
+    bool setup(int sampleRate = 16000, float ringSeconds = 10.0f);
+    void close();
+
+    // Call from audioIn(). Never blocks.
+    void process(const ofSoundBuffer& input);
+
+    // blockSize: samples per callback, 0 delivers whatever is available.
+    // maxLagSeconds: skip ahead once further behind than this, 0 uses the ring size.
+    int addConsumer(const std::string& name, Consumer callback, size_t blockSize = 0, float maxLagSeconds = 0.0f);
+    void removeConsumer(int id);
+
+    std::vector<ConsumerStats> getConsumerStats();
+    int getSampleRate() const { return sampleRate; }
+
+private:
+    struct ConsumerSlot {
+        int id = 0;
+        std::string name;
+        Consumer callback;
+        size_t blockSize = 0;
+        uint64_t maxLagSamples = 0;
+        uint64_t cursor = 0;
+        std::atomic<uint64_t> samplesDelivered{0};
+        std::atomic<uint64_t> samplesDropped{0};
+        std::atomic<uint64_t> readPosition{0};
+        std::atomic<bool> running{true};
+        std::thread thread;
+    };
+    void consumerLoop(ConsumerSlot* consumer);
+    void stopConsumer(ConsumerSlot& consumer);
+
+    int sampleRate = 16000;
+    // Relaxed atomics so a consumer being lapped mid-copy is a detectable torn
+    // read rather than a data race; they compile to plain loads and stores.
+    std::unique_ptr<std::atomic<float>[]> ring;
+    uint64_t ringSize = 0;
+    uint64_t ringMask = 0;
+    std::atomic<uint64_t> writePosition{0}; // Total samples ever written
+
+    // Resampler state carried across device buffers
+    std::vector<float> monoBuffer;
+    std::vector<float> resampledBuffer;
+    double resamplePosition = 0.0; // Next output position in input samples, relative to the current buffer
+    float lastInputSample = 0.0f;
+    unsigned lastInputRate = 0;
+
+    std::mutex consumersMutex; // Guards consumers; never taken by process()
+    std::vector<std::unique_ptr<ConsumerSlot>> consumers;
+    int nextConsumerId = 0;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+};
@@ -0,0 +1,382 @@
+/*
+ * ofxSherpaOnnx
+ *
+ * Copyright (c) 2025 Yannick Hofmann
+ * <contact@yannickhofmann.de>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include "ofxSherpaOnnxJournal.h"
+#include <cctype>
+#include <cstring>
+#include <unistd.h> // For fsync
+
+namespace {
+    const char binaryMagic[4] = { 'S', 'O', 'J', '1' };
+    const size_t binaryRecordHeaderSize = sizeof(uint64_t) + 2 * sizeof(double);
+
+    std::string escapeJson(const std::string& text) {
+        std::string out;
+        out.reserve(text.size() + 8);
+        for (unsigned char c : text) {
+            switch (c) {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (c < 0x20) {
+                        char buf[8];
+                        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                        out += buf;
+                    } else {
+                        out += static_cast<char>(c);
+                    }
+            }
+        }
+        return out;
+    }
+
+    // Reads the four hex digits of a \uXXXX escape starting at line[pos].
+    bool parseHex4(const std::string& line, size_t pos, uint32_t& value) {
+        if (pos + 4 > line.size()) return false;
+        for (size_t i = pos; i < pos + 4; ++i) {
+            if (!std::isxdigit(static_cast<unsigned char>(line[i]))) return false;
+        }
+        value = static_cast<uint32_t>(std::strtoul(line.substr(pos, 4).c_str(), nullptr, 16));
+        return true;
+    }
+
+    void appendUtf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    // Parses the JSON string starting at line[pos] (which must be '"').
+    bool parseJsonString(const std::string& line, size_t pos, std::string& out) {
+        if (pos >= line.size() || line[pos] != '"') return false;
+        out.clear();
+        for (size_t i = pos + 1; i < line.size(); ++i) {
+            char c = line[i];
+            if (c == '"') return true;
+            if (c != '\\') { out += c; continue; }
+            if (++i >= line.size()) return false;
+            switch (line[i]) {
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    uint32_t cp = 0;
+                    if (!parseHex4(line, i + 1, cp)) return false;
+                    i += 4;
+                    if (cp >= 0xDC00 && cp < 0xE000) return false; // Unpaired low surrogate
+                    if (cp >= 0xD800 && cp < 0xDC00) {
+                        uint32_t low = 0;
+                        if (i + 2 >= line.size() || line[i + 1] != '\\' || line[i + 2] != 'u' ||
+                            !parseHex4(line, i + 3, low) || low < 0xDC00 || low >= 0xE000) {
+                            return false;
+                        }
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                    appendUtf8(out, cp);
+                    break;
+                }
+                default: out += line[i]; break;
+            }
+        }
+        return false;
+    }
+
+    size_t findJsonValue(const std::string& line, const std::string& key) {
+        size_t pos = line.find("\"" + key + "\":");
+        return pos == std::string::npos ? pos : pos + key.size() + 3;
+    }
+}
+
+ofxSherpaOnnxJournal::ofxSherpaOnnxJournal() {}
+
+ofxSherpaOnnxJournal::~ofxSherpaOnnxJournal() {
+    close();
+}
+
+bool ofxSherpaOnnxJournal::setup(const Settings& newSettings) {
+    close();
+
+    if (newSettings.basePath.empty() || newSettings.queueCapacity == 0) {
+        ofLogError("ofxSherpaOnnxJournal::setup") << "A base path and a non-zero queue capacity are required.";
+        return false;
+    }
+    settings = newSettings;
+
+    std::string dir = ofFilePath::getEnclosingDirectory(settings.basePath, false);
+    if (!dir.empty() && !ofDirectory(dir).exists()) {
+        ofDirectory::createDirectory(dir, false, true);
+    }
+
+    capacity = settings.queueCapacity;
+    slots.reset(new Slot[capacity]);
+    for (size_t i = 0; i < capacity; ++i) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueuePos.store(0);
+    dequeuePos = 0;
+    fileIndex = 0;
+
+    if (!openNextFile()) {
+        return false;
+    }
+
+    running = true;
+    writerThread = std::thread(&ofxSherpaOnnxJournal::writerLoop, this);
+
+    ofLogNotice("ofxSherpaOnnxJournal::setup") << "Journaling to " << getCurrentFilePath();
+    return true;
+}
+
+void ofxSherpaOnnxJournal::close() {
+    if (running.exchange(false)) {
+        wakeCondition.notify_all();
+    }
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+    closeFile();
+}
+
+bool ofxSherpaOnnxJournal::append(ofxSherpaOnnxTranscriptEntry entry) {
+    if (!running.load(std::memory_order_relaxed)) return false;
+
+    Slot* slot = nullptr;
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        slot = &slots[pos % capacity];
+        size_t seq = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            numDropped++;
+            return false;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    slot->entry = std::move(entry);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool ofxSherpaOnnxJournal::dequeue(ofxSherpaOnnxTranscriptEntry& entry) {
+    Slot& slot = slots[dequeuePos % capacity];
+    size_t seq = slot.sequence.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(dequeuePos + 1) < 0) {
+        return false;
+    }
+    entry = std::move(slot.entry);
+    slot.sequence.store(dequeuePos + capacity, std::memory_order_release);
+    dequeuePos++;
+    return true;
+}
+
+std::string ofxSherpaOnnxJournal::getCurrentFilePath() {
+    std::lock_guard<std::mutex> lock(pathMutex);
+    return currentFilePath;
+}
+
+void ofxSherpaOnnxJournal::writerLoop() {
+    ofxSherpaOnnxTranscriptEntry entry;
+    bool keepRunning = true;
+    while (keepRunning) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCondition.wait_for(lock, std::chrono::milliseconds(settings.flushIntervalMs), [this] { return !running.load(); });
+        }
+        // Drain once more after close() so nothing queued before it is lost.
+        keepRunning = running.load();
+
+        size_t batchSize = 0;
+        while (dequeue(entry)) {
+            uint64_t ageMs = ofGetSystemTimeMillis() - currentFileOpenedMs;
+            bool tooBig = settings.maxFileBytes > 0 && currentFileBytes >= settings.maxFileBytes;
+            bool tooOld = settings.maxFileAgeSeconds > 0 && ageMs >= static_cast<uint64_t>(settings.maxFileAgeSeconds) * 1000;
+            if (!file || tooBig || tooOld) {
+                if (!openNextFile()) {
+                    numDropped++;
+                    continue;
+                }
+            }
+            writeEntry(entry);
+            batchSize++;
+        }
+
+        if (batchSize > 0 && file) {
+            std::fflush(file);
+            if (settings.fsyncPolicy == FsyncPolicy::EveryBatch) {
+                syncFile();
+            }
+            numWritten += batchSize;
+        }
+    }
+}
+
+bool ofxSherpaOnnxJournal::openNextFile() {
+    closeFile();
+
+    std::string ext = settings.format == Format::Binary ? ".bin" : ".ndjson";
+    std::string path = settings.basePath + "-" + ofGetTimestampString("%Y%m%d-%H%M%S") + "-" + ofToString(fileIndex++) + ext;
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        ofLogError("ofxSherpaOnnxJournal") << "Failed to open journal file: " << path;
+        return false;
+    }
+    // Batches are flushed explicitly, so a large stdio buffer keeps write syscalls to one per batch.
+    fileBuffer.resize(64 * 1024);
+    std::setvbuf(file, fileBuffer.data(), _IOFBF, fileBuffer.size());
+
+    currentFileBytes = 0;
+    currentFileOpenedMs = ofGetSystemTimeMillis();
+    if (settings.format == Format::Binary) {
+        std::fwrite(binaryMagic, 1, sizeof(binaryMagic), file);
+        currentFileBytes += sizeof(binaryMagic);
+    }
+
+    std::lock_guard<std::mutex> lock(pathMutex);
+    currentFilePath = path;
+    return true;
+}
+
+void ofxSherpaOnnxJournal::closeFile() {
+    if (!file) return;
+    std::fflush(file);
+    if (settings.fsyncPolicy != FsyncPolicy::None) {
+        syncFile();
+    }
+    std::fclose(file);
+    file = nullptr;
+}
+
+void ofxSherpaOnnxJournal::syncFile() {
+    if (file) {
+        fsync(fileno(file));
+    }
+}
+
+void ofxSherpaOnnxJournal::writeEntry(const ofxSherpaOnnxTranscriptEntry& entry) {
+    if (settings.format == Format::Binary) {
+        // Record layout (host byte order): uint32 payload size, uint64 wall time,
+        // double start, double end, then the UTF-8 text.
+        uint32_t payloadSize = static_cast<uint32_t>(binaryRecordHeaderSize + entry.text.size());
+        char header[sizeof(uint32_t) + binaryRecordHeaderSize];
+        char* p = header;
+        std::memcpy(p, &payloadSize, sizeof(payloadSize)); p += sizeof(payloadSize);
+        std::memcpy(p, &entry.wallTimeMs, sizeof(entry.wallTimeMs)); p += sizeof(entry.wallTimeMs);
+        std::memcpy(p, &entry.startSeconds, sizeof(entry.startSeconds)); p += sizeof(entry.startSeconds);
+        std::memcpy(p, &entry.endSeconds, sizeof(entry.endSeconds));
+        std::fwrite(header, 1, sizeof(header), file);
+        std::fwrite(entry.text.data(), 1, entry.text.size(), file);
+        currentFileBytes += sizeof(header) + entry.text.size();
+    } else {
+        char prefix[128];
+        int n = std::snprintf(prefix, sizeof(prefix), "{\"wall_ms\":%llu,\"start\":%.3f,\"end\":%.3f,\"text\":\"",
+                              static_cast<unsigned long long>(entry.wallTimeMs), entry.startSeconds, entry.endSeconds);
+        std::string line(prefix, n);
+        line += escapeJson(entry.text);
+        line += "\"}\n";
+        std::fwrite(line.data(), 1, line.size(), file);
+        currentFileBytes += line.size();
+    }
+}
+
+bool ofxSherpaOnnxJournal::readFile(const std::string& filePath, std::vector<ofxSherpaOnnxTranscriptEntry>& entries) {
+    std::FILE* in = std::fopen(filePath.c_str(), "rb");
+    if (!in) {
+        ofLogError("ofxSherpaOnnxJournal::readFile") << "Failed to open journal file: " << filePath;
+        return false;
+    }
+
+    char magic[sizeof(binaryMagic)] = {};
+    bool isBinary = std::fread(magic, 1, sizeof(magic), in) == sizeof(magic) && std::memcmp(magic, binaryMagic, sizeof(magic)) == 0;
+    bool ok = true;
+
+    if (isBinary) {
+        std::fseek(in, 0, SEEK_END);
+        long fileSize = std::ftell(in);
+        std::fseek(in, sizeof(binaryMagic), SEEK_SET);
+
+        uint32_t payloadSize = 0;
+        while (std::fread(&payloadSize, sizeof(payloadSize), 1, in) == 1) {
+            if (payloadSize < binaryRecordHeaderSize) { ok = false; break; }
+            // Check the length against what is left before allocating, so a corrupt
+            // prefix cannot ask for gigabytes.
+            long remaining = fileSize - std::ftell(in);
+            if (remaining < 0 || payloadSize > static_cast<unsigned long>(remaining)) {
+                ofLogWarning("ofxSherpaOnnxJournal::readFile") << "Truncated record at end of " << filePath;
+                break;
+            }
+            std::vector<char> payload(payloadSize);
+            if (std::fread(payload.data(), 1, payloadSize, in) != payloadSize) {
+                // A truncated tail record means the writer was interrupted; keep what we have.
+                ofLogWarning("ofxSherpaOnnxJournal::readFile") << "Truncated record at end of " << filePath;
+                break;
+            }
+            ofxSherpaOnnxTranscriptEntry entry;
+            const char* p = payload.data();
+            std::memcpy(&entry.wallTimeMs, p, sizeof(entry.wallTimeMs)); p += sizeof(entry.wallTimeMs);
+            std::memcpy(&entry.startSeconds, p, sizeof(entry.startSeconds)); p += sizeof(entry.startSeconds);
+            std::memcpy(&entry.endSeconds, p, sizeof(entry.endSeconds)); p += sizeof(entry.endSeconds);
+            entry.text.assign(p, payloadSize - binaryRecordHeaderSize);
+            entries.push_back(std::move(entry));
+        }
+    } else {
+        std::rewind(in);
+        std::string line;
+        char buf[4096];
+        while (std::fgets(buf, sizeof(buf), in)) {
+            line += buf;
+            if (line.empty() || (line.back() != '\n' && !std::feof(in))) continue;
+
+            ofxSherpaOnnxTranscriptEntry entry;
+            size_t wallPos = findJsonValue(line, "wall_ms");
+            size_t startPos = findJsonValue(line, "start");
+            size_t endPos = findJsonValue(line, "end");
+            size_t textPos = findJsonValue(line, "text");
+            if (wallPos == std::string::npos || startPos == std::string::npos || endPos == std::string::npos ||
+                textPos == std::string::npos || !parseJsonString(line, textPos, entry.text)) {
+                if (line.find_first_not_of(" \t\r\n") != std::string::npos) {
+                    ofLogWarning("ofxSherpaOnnxJournal::readFile") << "Skipping malformed line in " << filePath;
+                }
+                line.clear();
+                continue;
+            }
+            entry.wallTimeMs = std::strtoull(line.c_str() + wallPos, nullptr, 10);
+            entry.startSeconds = std::strtod(line.c_str() + startPos, nullptr);
+            entry.endSeconds = std::strtod(line.c_str() + endPos, nullptr);
+            entries.push_back(std::move(entry));
+            line.clear();
+        }
+    }
+
+    std::fclose(in);
+    return ok;
+}
@@ -0,0 +1,108 @@
+/*
+ * ofxSherpaOnnx
+ *
+ * Copyright (c) 2025 Yannick Hofmann
+ * <contact@yannickhofmann.de>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// One finalized ASR segment as written to the journal.
+struct ofxSherpaOnnxTranscriptEntry {
+    uint64_t wallTimeMs = 0;    // System time (ms since epoch) when the segment was finalized
+    double startSeconds = 0.0;  // Segment start, in seconds of audio fed to the recognizer
+    double endSeconds = 0.0;    // Segment end, in seconds of audio fed to the recognizer
+    std::string text;
+};
+
+// Append-only transcript log. append() is lock-free and never touches the
+// disk; a background thread drains the queue in batches, writes them with
+// buffered I/O, and rotates files by size and age.
+class ofxSherpaOnnxJournal {
+public:
+    enum class Format {
+        NDJSON,  // One JSON object per line (.ndjson)
+        Binary   // "SOJ1" header followed by length-prefixed records (.bin)
+    };
+
+    enum class FsyncPolicy {
+        None,        // Leave flushing to the OS
+        EveryBatch,  // fsync after each written batch
+        OnRotate     // fsync only when a file is closed
+    };
+
+    struct Settings {
+        std::string basePath;              // Files are named <basePath>-<timestamp>-<n>.<ext>
+        Format format = Format::NDJSON;
+        FsyncPolicy fsyncPolicy = FsyncPolicy::None;
+        size_t queueCapacity = 1024;       // Entries held in memory before append() starts dropping
+        int flushIntervalMs = 250;         // How often the writer thread drains the queue
+        uint64_t maxFileBytes = 16 * 1024 * 1024; // Rotate when exceeded, 0 disables
+        int maxFileAgeSeconds = 3600;      // Rotate when exceeded, 0 disables
+    };
+
+    ofxSherpaOnnxJournal();
+    ~ofxSherpaOnnxJournal();
+
+    bool setup(const Settings& settings);
+    void close();
+    bool isOpen() const { return running.load(); }
+
+    // Safe to call from the audio thread. Returns false (and counts the entry
+    // as dropped) if the queue is full.
+    bool append(ofxSherpaOnnxTranscriptEntry entry);
+
+    uint64_t getNumWritten() const { return numWritten.load(); }
+    uint64_t getNumDropped() const { return numDropped.load(); }
+    std::string getCurrentFilePath();
+
+    // Reader utility: loads every entry from a journal file of either format.
+    static bool readFile(const std::string& filePath, std::vector<ofxSherpaOnnxTranscriptEntry>& entries);
+
+private:
+    // Bounded multi-producer / single-consumer queue (per-slot sequence numbers).
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        ofxSherpaOnnxTranscriptEntry entry;
+    };
+    std::unique_ptr<Slot[]> slots;
+    size_t capacity = 0;
+    std::atomic<size_t> enqueuePos{0};
+    size_t dequeuePos = 0;
+    bool dequeue(ofxSherpaOnnxTranscriptEntry& entry);
+
+    void writerLoop();
+    bool openNextFile();
+    void closeFile();
+    void writeEntry(const ofxSherpaOnnxTranscriptEntry& entry);
+    void syncFile();
+
+    Settings settings;
+    std::thread writerThread;
+    std::atomic<bool> running{false};
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+
+    std::FILE* file = nullptr;
+    std::vector<char> fileBuffer;
+    std::mutex pathMutex;
+    std::string currentFilePath;
+    uint64_t currentFileBytes = 0;
+    uint64_t currentFileOpenedMs = 0;
+    int fileIndex = 0;
+
+    std::atomic<uint64_t> numWritten{0};
+    std::atomic<uint64_t> numDropped{0};
+};
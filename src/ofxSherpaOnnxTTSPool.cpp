@@ -0,0 +1,163 @@
+/*
+ * ofxSherpaOnnx
+ *
+ * Copyright (c) 2025 Yannick Hofmann
+ * <contact@yannickhofmann.de>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include "ofxSherpaOnnxTTSPool.h"
+
+namespace {
+    const size_t maxRecordedLatencies = 1024;
+}
+
+ofxSherpaOnnxTTSPool::ofxSherpaOnnxTTSPool() {}
+
+ofxSherpaOnnxTTSPool::~ofxSherpaOnnxTTSPool() {
+    close();
+}
+
+bool ofxSherpaOnnxTTSPool::setup(const std::string& modelPath, const std::string& lexiconPath, const std::string& tokensPath, float noiseScale, float noiseW, float lengthScale) {
+    return setup(modelPath, lexiconPath, tokensPath, noiseScale, noiseW, lengthScale, Settings());
+}
+
+bool ofxSherpaOnnxTTSPool::setup(const std::string& modelPath, const std::string& lexiconPath, const std::string& tokensPath, float noiseScale, float noiseW, float lengthScale, const Settings& newSettings) {
+    close();
+
+    settings = newSettings;
+    settings.numEngines = std::max(1, settings.numEngines);
+
+    for (int i = 0; i < settings.numEngines; ++i) {
+        std::unique_ptr<ofxSherpaOnnx> engine(new ofxSherpaOnnx());
+        if (!engine->setupTTS(modelPath, lexiconPath, tokensPath, noiseScale, noiseW, lengthScale)) {
+            ofLogError("ofxSherpaOnnxTTSPool::setup") << "Failed to set up TTS engine " << i << ".";
+            engines.clear();
+            return false;
+        }
+        engines.push_back(std::move(engine));
+    }
+
+    resetStats();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        running = true;
+    }
+    for (auto& engine : engines) {
+        engineThreads.emplace_back(&ofxSherpaOnnxTTSPool::engineLoop, this, engine.get());
+    }
+
+    ofLogNotice("ofxSherpaOnnxTTSPool::setup") << "TTS pool running with " << settings.numEngines << " engines.";
+    return true;
+}
+
+void ofxSherpaOnnxTTSPool::close() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        running = false;
+    }
+    queueCondition.notify_all();
+    // Engine threads drain the queue before exiting, so every future is fulfilled.
+    for (auto& thread : engineThreads) {
+        thread.join();
+    }
+    engineThreads.clear();
+    engines.clear();
+}
+
+std::future<ofxSherpaOnnxTTSPool::Result> ofxSherpaOnnxTTSPool::submit(const std::string& text, int speakerId, float speed) {
+    Request request;
+    request.text = text;
+    request.speakerId = speakerId;
+    request.speed = speed;
+    request.submittedAt = std::chrono::steady_clock::now();
+    std::future<Result> future = request.promise.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        if (!statsStarted) {
+            statsStarted = true;
+            firstSubmission = request.submittedAt;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(queueMutex);
+    if (!running) {
+        lock.unlock();
+        ofLogError("ofxSherpaOnnxTTSPool::submit") << "TTS pool not running. Call setup() first.";
+        request.promise.set_value(Result());
+        return future;
+    }
+    queue.push_back(std::move(request));
+    lock.unlock();
+    queueCondition.notify_one();
+    return future;
+}
+
+bool ofxSherpaOnnxTTSPool::generate(const std::string& text, std::vector<float>& audioSamples, int& sampleRate, int speakerId, float speed) {
+    Result result = submit(text, speakerId, speed).get();
+    if (!result.success) return false;
+    audioSamples = std::move(result.samples);
+    sampleRate = result.sampleRate;
+    return true;
+}
+
+void ofxSherpaOnnxTTSPool::engineLoop(ofxSherpaOnnx* engine) {
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return !running || !queue.empty(); });
+            if (queue.empty()) return; // Only reached once closed and drained
+            request = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        Result result;
+        result.success = engine->generateTTS(request.text, result.samples, result.sampleRate, request.speakerId, request.speed);
+        result.latencyMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - request.submittedAt).count();
+        recordLatency(result.latencyMs);
+        request.promise.set_value(std::move(result));
+    }
+}
+
+void ofxSherpaOnnxTTSPool::recordLatency(float latencyMs) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    requestsCompleted++;
+    lastCompletion = std::chrono::steady_clock::now();
+    if (latencies.size() < maxRecordedLatencies) {
+        latencies.push_back(latencyMs);
+    } else {
+        latencies[latencyCursor] = latencyMs;
+        latencyCursor = (latencyCursor + 1) % maxRecordedLatencies;
+    }
+}
+
+ofxSherpaOnnxTTSPool::Stats ofxSherpaOnnxTTSPool::getStats() {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    Stats stats;
+    stats.requestsCompleted = requestsCompleted;
+
+    if (!latencies.empty()) {
+        std::vector<float> sorted(latencies);
+        std::sort(sorted.begin(), sorted.end());
+        stats.p50LatencyMs = sorted[(sorted.size() - 1) * 50 / 100];
+        stats.p99LatencyMs = sorted[(sorted.size() - 1) * 99 / 100];
+    }
+    if (requestsCompleted > 0) {
+        float elapsed = std::chrono::duration<float>(lastCompletion - firstSubmission).count();
+        stats.utterancesPerSecond = elapsed > 0.0f ? requestsCompleted / elapsed : 0.0f;
+    }
+    return stats;
+}
+
+void ofxSherpaOnnxTTSPool::resetStats() {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    requestsCompleted = 0;
+    latencies.clear();
+    latencyCursor = 0;
+    statsStarted = false;
+}
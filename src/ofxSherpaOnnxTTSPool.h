@@ -0,0 +1,89 @@
+/*
+ * ofxSherpaOnnx
+ *
+ * Copyright (c) 2025 Yannick Hofmann
+ * <contact@yannickhofmann.de>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxSherpaOnnx.h"
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Pool of TTS engines for many concurrent callers. Requests are served in
+// arrival order, each by whichever engine becomes free first; nothing is held
+// back while an engine is idle. Every engine loads its own copy of the model.
+class ofxSherpaOnnxTTSPool {
+public:
+    struct Settings {
+        int numEngines = 2; // Synthesizer instances working in parallel (each loads the model)
+    };
+
+    struct Result {
+        bool success = false;
+        std::vector<float> samples;
+        int sampleRate = 0;
+        float latencyMs = 0.0f; // Submission to completion
+    };
+
+    struct Stats {
+        uint64_t requestsCompleted = 0;
+        float p50LatencyMs = 0.0f;
+        float p99LatencyMs = 0.0f;
+        float utterancesPerSecond = 0.0f; // Completed requests over the time since the first submission
+    };
+
+    ofxSherpaOnnxTTSPool();
+    ~ofxSherpaOnnxTTSPool();
+
+    bool setup(const std::string& modelPath, const std::string& lexiconPath, const std::string& tokensPath, float noiseScale, float noiseW, float lengthScale, const Settings& settings);
+    bool setup(const std::string& modelPath, const std::string& lexiconPath, const std::string& tokensPath, float noiseScale, float noiseW, float lengthScale);
+    // Finishes every request already submitted, then releases the engines.
+    void close();
+
+    // Thread-safe; any number of callers may submit concurrently.
+    std::future<Result> submit(const std::string& text, int speakerId = 0, float speed = 1.0f);
+    // Blocking convenience with the same signature style as ofxSherpaOnnx::generateTTS().
+    bool generate(const std::string& text, std::vector<float>& audioSamples, int& sampleRate, int speakerId = 0, float speed = 1.0f);
+
+    Stats getStats();
+    void resetStats();
+
+private:
+    struct Request {
+        std::string text;
+        int speakerId = 0;
+        float speed = 1.0f;
+        std::chrono::steady_clock::time_point submittedAt;
+        std::promise<Result> promise;
+    };
+    void engineLoop(ofxSherpaOnnx* engine);
+    void recordLatency(float latencyMs);
+
+    Settings settings;
+    std::vector<std::unique_ptr<ofxSherpaOnnx>> engines;
+    std::vector<std::thread> engineThreads;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<Request> queue;
+    bool running = false;
+
+    std::mutex statsMutex;
+    uint64_t requestsCompleted = 0;
+    std::vector<float> latencies; // Ring of the most recent latencies for percentiles
+    size_t latencyCursor = 0;
+    bool statsStarted = false;
+    std::chrono::steady_clock::time_point firstSubmission;
+    std::chrono::steady_clock::time_point lastCompletion;
+};